@@ -0,0 +1,194 @@
+#!/usr/bin/env python3
+"""compareCPU_GPU.py - compare hipSolverBenchmark results
+
+Reads the JSON written by hipSolverBenchmark (see runBenchmarks.sh) and
+
+- prints the median time of every kernel per result file, with the speedup
+  of each file over the first one (e.g. hip over host),
+- optionally plots time against mesh size for every kernel (--plot),
+- optionally flags regressions against a baseline file, for example the
+  results of the previous commit (--baseline, --threshold). The exit status
+  is 1 if any kernel got slower by more than the threshold or a solve needs
+  more iterations.
+
+Usage:
+    compareCPU_GPU.py results/abc123-host.json results/abc123-hip.json
+    compareCPU_GPU.py results/new-host.json --baseline results/old-host.json
+    compareCPU_GPU.py results/*-host.json --plot scaling.png
+"""
+
+import argparse
+import json
+import sys
+
+
+def load(path):
+    with open(path) as f:
+        data = json.load(f)
+
+    if data.get("benchmark") != "hipSolverBenchmark":
+        sys.exit(f"{path}: not a hipSolverBenchmark result")
+
+    return data
+
+
+def name(data):
+    label = data.get("label") or "-"
+    return f"{label}/{data['backend']}"
+
+
+def records(data):
+    """Results keyed by (mesh, nCells, kernel)"""
+    return {(r["mesh"], r["nCells"], r["kernel"]): r for r in data["results"]}
+
+
+def table(runs):
+    keyed = [records(data) for data in runs]
+
+    keys = []
+    for rs in keyed:
+        keys.extend(k for k in rs if k not in keys)
+
+    header = f"{'mesh':<13}{'cells':>10}  {'kernel':<28}"
+    for i, data in enumerate(runs):
+        header += f"{name(data):>22}"
+        if i:
+            header += f"{'speedup':>9}"
+    print(header)
+    print("-"*len(header))
+
+    for key in keys:
+        mesh, cells, kernel = key
+        line = f"{mesh:<13}{cells:>10}  {kernel:<28}"
+        base = keyed[0].get(key)
+
+        for i, rs in enumerate(keyed):
+            r = rs.get(key)
+            if r is None:
+                line += f"{'-':>22}"
+            else:
+                cell = f"{r['p50']:.4g} ms"
+                if "iterations" in r:
+                    cell += f" ({int(r['iterations'])} it)"
+                line += f"{cell:>22}"
+
+            if i:
+                if r is not None and base is not None and r["p50"] > 0:
+                    line += f"{base['p50']/r['p50']:>8.2f}x"
+                else:
+                    line += f"{'-':>9}"
+        print(line)
+
+
+def regressions(baseline, runs, threshold):
+    """Kernels slower than baseline by more than threshold (relative p50)
+    or solves needing more iterations"""
+    base = records(baseline)
+    found = []
+
+    for data in runs:
+        for key, r in records(data).items():
+            b = base.get(key)
+            if b is None:
+                continue
+
+            ratio = r["p50"]/b["p50"] if b["p50"] > 0 else 1
+
+            # Ignore changes within the run-to-run noise of the baseline
+            noise = b["p90"]/b["p50"] - 1 if b["p50"] > 0 else 0
+
+            if ratio > 1 + max(threshold, noise):
+                found.append((name(data), key, f"p50 {b['p50']:.4g} -> "
+                              f"{r['p50']:.4g} ms ({ratio:.2f}x)"))
+
+            if r.get("iterations", 0) > b.get("iterations", 0):
+                found.append((name(data), key, f"iterations "
+                              f"{int(b['iterations'])} -> "
+                              f"{int(r['iterations'])}"))
+
+    return found
+
+
+def plot(runs, path):
+    try:
+        import matplotlib
+        matplotlib.use("Agg")
+        import matplotlib.pyplot as plt
+    except ImportError:
+        sys.exit("--plot needs matplotlib")
+
+    kernels = []
+    for data in runs:
+        for r in data["results"]:
+            if r["kernel"] not in kernels:
+                kernels.append(r["kernel"])
+
+    ncols = 3
+    nrows = (len(kernels) + ncols - 1)//ncols
+    fig, axes = plt.subplots(nrows, ncols, figsize=(5*ncols, 3.5*nrows),
+                             squeeze=False)
+
+    for ax, kernel in zip(axes.flat, kernels):
+        for data in runs:
+            meshes = sorted({r["mesh"] for r in data["results"]})
+            for mesh in meshes:
+                pts = sorted((r["nCells"], r["p50"], r["p90"])
+                             for r in data["results"]
+                             if r["kernel"] == kernel and r["mesh"] == mesh)
+                if not pts:
+                    continue
+                cells, p50, p90 = zip(*pts)
+                line, = ax.loglog(cells, p50, "o-",
+                                  label=f"{name(data)} {mesh}")
+                ax.fill_between(cells, p50, p90, alpha=0.2,
+                                color=line.get_color())
+        ax.set_title(kernel)
+        ax.set_xlabel("cells")
+        ax.set_ylabel("time [ms]")
+        ax.grid(True, which="both", alpha=0.3)
+        ax.legend(fontsize="x-small")
+
+    for ax in list(axes.flat)[len(kernels):]:
+        ax.set_visible(False)
+
+    fig.tight_layout()
+    fig.savefig(path, dpi=120)
+    print(f"\nScaling plot written to {path}")
+
+
+def main():
+    parser = argparse.ArgumentParser(
+        description="Compare hipSolverBenchmark results")
+    parser.add_argument("results", nargs="+", help="benchmark JSON files")
+    parser.add_argument("--baseline", help="flag regressions against this file")
+    parser.add_argument("--threshold", type=float, default=0.10,
+                        help="relative slowdown reported as a regression "
+                             "(default 0.10)")
+    parser.add_argument("--plot", help="write a scaling plot to this file")
+    args = parser.parse_args()
+
+    runs = [load(path) for path in args.results]
+
+    table(runs)
+
+    if args.plot:
+        plot(runs, args.plot)
+
+    if args.baseline:
+        baseline = load(args.baseline)
+        found = regressions(baseline, runs, args.threshold)
+
+        print(f"\nRegressions against {name(baseline)} "
+              f"(threshold {100*args.threshold:.0f}%):")
+        for run, (mesh, cells, kernel), what in found:
+            print(f"  {run:<20} {mesh:<13}{cells:>10}  {kernel:<28} {what}")
+        if not found:
+            print("  none")
+
+        return 1 if found else 0
+
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
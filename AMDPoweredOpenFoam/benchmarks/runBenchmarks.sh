@@ -0,0 +1,64 @@
+#!/bin/sh
+# runBenchmarks.sh - micro-benchmarks of the accelerated solver path
+#
+# Runs hipSolverBenchmark on structured and unstructured synthetic meshes for
+# every available backend, writes results/<label>-<backend>.json and compares
+# them with compareCPU_GPU.py. Unlike benchmark.sh no case is needed and the
+# timings exclude mesh I/O, turbulence and assembly.
+#
+# Usage: ./runBenchmarks.sh [cells] [baseline.json]
+#     cells     comma-separated mesh sizes (default 1e4,1e5,1e6)
+#     baseline  earlier result to check for regressions
+#
+# Environment: LABEL (default: short git commit), BENCHMARK_OPTIONS (extra
+# hipSolverBenchmark options, e.g. "-preconditioners Jacobi,AMG").
+
+cd "${0%/*}" || exit
+
+CELLS=${1:-1e4,1e5,1e6}
+BASELINE=$2
+LABEL=${LABEL:-$(git rev-parse --short HEAD 2>/dev/null || echo local)}
+
+if ! command -v hipSolverBenchmark >/dev/null 2>&1
+then
+    echo "ERROR: hipSolverBenchmark not found, build it with ./Allwmake"
+    exit 1
+fi
+
+mkdir -p results
+
+RESULTS=""
+
+for BACKEND in host hip
+do
+    OUTPUT=results/$LABEL-$BACKEND.json
+
+    echo "Benchmarking the $BACKEND backend ($CELLS cells)"
+
+    # The hip backend is skipped when it is not compiled in
+    if hipSolverBenchmark -backend $BACKEND -mesh structured,unstructured \
+        -cells "$CELLS" -label "$LABEL" -output "$OUTPUT" $BENCHMARK_OPTIONS
+    then
+        RESULTS="$RESULTS $OUTPUT"
+    else
+        echo "  $BACKEND backend not available, skipped"
+        rm -f "$OUTPUT"
+    fi
+done
+
+[ -n "$RESULTS" ] || exit 1
+
+echo ""
+
+PLOT=""
+if python3 -c "import matplotlib" >/dev/null 2>&1
+then
+    PLOT="--plot results/$LABEL-scaling.png"
+fi
+
+if [ -n "$BASELINE" ]
+then
+    python3 compareCPU_GPU.py $RESULTS $PLOT --baseline "$BASELINE"
+else
+    python3 compareCPU_GPU.py $RESULTS $PLOT
+fi
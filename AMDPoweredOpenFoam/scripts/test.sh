@@ -0,0 +1,207 @@
+#!/bin/sh
+# test.sh - build and run the regression tests
+#
+# testHIPSolvers checks the OpenFOAM-independent core (backend accounting,
+# Krylov solvers, preconditioners) on the host backend, so it runs on
+# machines without a GPU. Build the library first with ./Allwmake.
+#
+# tests/parallelCase is then solved serially with laplacianFoam, once with
+# OpenFOAM's GAMG and once each with hipPCG/AMG and hipPCG/DIC on the host
+# backend. The iterations and ExecutionTime of the three are reported; all
+# must reach the tolerance, AMG must need fewer iterations than DIC and at
+# most MAX_GAMG_ITER_RATIO times those of GAMG.
+#
+# Finally the case is solved with the hipPCG and hipPBiCGStab solvers on
+# the host backend, serially and decomposed on 2 and 4 ranks. Every decomposed solve must match the serial one: same
+# number of solves, iterations within MAX_ITER_DIFF, initial residuals
+# within a relative REL_RESIDUAL_DIFF and final residuals at the
+# tolerance. Skipped if mpirun is not available.
+#
+# Usage: scripts/test.sh [test]...
+#     test  names of the testHIPSolvers tests to run (default: all)
+
+cd "${0%/*}/.." || exit
+
+if [ -z "$WM_PROJECT_DIR" ]
+then
+    echo "ERROR: OpenFOAM environment not loaded!"
+    exit 1
+fi
+
+NPROCS=${NPROCS:-"2 4"}
+MAX_ITER_DIFF=${MAX_ITER_DIFF:-2}
+REL_RESIDUAL_DIFF=${REL_RESIDUAL_DIFF:-1e-3}
+MAX_GAMG_ITER_RATIO=${MAX_GAMG_ITER_RATIO:-3}
+
+echo "Building testHIPSolvers..."
+wmake tests || exit 1
+
+echo ""
+echo "Running testHIPSolvers..."
+testHIPSolvers "$@" || exit 1
+
+# Initial residual, final residual and iterations of every solve in a log
+solves()
+{
+    sed -n 's/.*Solving for T, Initial residual = \([^,]*\), Final residual = \([^,]*\), No Iterations \([0-9]*\).*/\1 \2 \3/p' "$1"
+}
+
+# Compare the solves of a decomposed run against the serial run
+compare()
+{
+    solves "$1" > "$1.solves"
+    solves "$2" > "$2.solves"
+
+    paste -d ' ' "$1.solves" "$2.solves" | awk \
+        -v name="$3" \
+        -v nSerial="$(wc -l < "$1.solves")" \
+        -v nParallel="$(wc -l < "$2.solves")" \
+        -v maxIterDiff="$MAX_ITER_DIFF" \
+        -v relDiff="$REL_RESIDUAL_DIFF" \
+        -v tolerance=1e-6 '
+        function abs(x) { return x < 0 ? -x : x }
+        {
+            ok = abs($6 - $3) <= maxIterDiff \
+              && abs($4 - $1) <= relDiff*$1 \
+              && $2 <= tolerance && $5 <= tolerance
+            if (!ok) {
+                printf "    solve %d: serial %s %s %d, %s %s %s %d\n", \
+                    NR, $1, $2, $3, name, $4, $5, $6
+                failed++
+            }
+            maxDiff = abs($6 - $3) > maxDiff ? abs($6 - $3) : maxDiff
+        }
+        END {
+            if (nSerial == 0 || nSerial != nParallel) {
+                printf "    %d serial solves, %d %s solves\n", \
+                    nSerial, nParallel, name
+                failed++
+            }
+            printf "  %-16s %3d solves, max iteration difference %d: %s\n", \
+                name, nParallel, maxDiff, failed ? "FAILED" : "ok"
+            exit failed ? 1 : 0
+        }'
+}
+
+# Copy tests/parallelCase to $1, set the T solver entries given as
+# name=value pairs and make the mesh
+setupCase()
+{
+    run="$1"
+    shift
+
+    cp -r tests/parallelCase "$run"
+
+    for entry in "$@"
+    do
+        foamDictionary -case "$run" -entry "solvers/T/${entry%%=*}" \
+            -set "${entry#*=}" system/fvSolution > /dev/null || exit 1
+    done
+
+    blockMesh -case "$run" > "$run/log.blockMesh" 2>&1 || exit 1
+}
+
+# Serial run of a case into log.serial
+runSerial()
+{
+    laplacianFoam -case "$1" > "$1/log.serial" 2>&1 || {
+        echo "serial run of $1 failed:"
+        cat "$1/log.serial"
+        exit 1
+    }
+}
+
+# Total iterations, largest final residual and ExecutionTime of a log
+summary()
+{
+    solves "$1" | awk '
+        { n += $3; if ($2 > r) r = $2 }
+        END { printf "%d %g", n, r }'
+    printf ' %s\n' "$(sed -n 's/^ExecutionTime = \([^ ]*\) s.*/\1/p' "$1" | tail -1)"
+}
+
+caseDir=$(mktemp -d) || exit 1
+trap 'rm -rf "$caseDir"' EXIT
+
+# One thread per process, so the timings compare like with like and the
+# decomposed runs do not oversubscribe
+export OMP_NUM_THREADS=1
+
+failed=0
+
+echo ""
+echo "Comparing with GAMG on tests/parallelCase..."
+
+setupCase "$caseDir/GAMG" solver=GAMG smoother=DICGaussSeidel
+setupCase "$caseDir/AMG" preconditioner=AMG
+setupCase "$caseDir/DIC" preconditioner=DIC
+
+for run in GAMG AMG DIC
+do
+    runSerial "$caseDir/$run"
+    summary "$caseDir/$run/log.serial" > "$caseDir/$run.summary"
+done
+
+cat "$caseDir/GAMG.summary" "$caseDir/AMG.summary" "$caseDir/DIC.summary" \
+    | awk -v maxRatio="$MAX_GAMG_ITER_RATIO" -v tolerance=1e-6 '
+    BEGIN { split("GAMG hipPCG/AMG hipPCG/DIC", name, " ") }
+    {
+        nIter[NR] = $1
+        printf "  %-12s %5d iterations, final residual <= %-10g %8s s\n", \
+            name[NR], $1, $2, $3
+        if (!($2 <= tolerance)) {
+            printf "    %s did not reach the tolerance\n", name[NR]
+            failed++
+        }
+    }
+    END {
+        if (!(nIter[2] < nIter[3])) {
+            print "    hipPCG/AMG does not beat hipPCG/DIC"
+            failed++
+        }
+        if (!(nIter[2] <= maxRatio*nIter[1])) {
+            printf "    hipPCG/AMG needs more than %g times the GAMG iterations\n", \
+                maxRatio
+            failed++
+        }
+        print "  " (failed ? "FAILED" : "ok")
+        exit failed ? 1 : 0
+    }' || failed=1
+
+if ! command -v mpirun >/dev/null 2>&1
+then
+    echo ""
+    echo "mpirun not found, skipping the decomposed runs"
+    exit $failed
+fi
+
+echo ""
+echo "Running tests/parallelCase serially and decomposed..."
+
+for solver in hipPCG hipPBiCGStab
+do
+    run="$caseDir/$solver"
+    setupCase "$run" solver="$solver"
+    runSerial "$run"
+
+    for np in $NPROCS
+    do
+        dict="system/decomposeParDict.$np"
+
+        rm -rf "$run"/processor*
+        decomposePar -case "$run" -decomposeParDict "$dict" \
+            > "$run/log.decomposePar.$np" 2>&1 || exit 1
+
+        mpirun -np "$np" laplacianFoam -case "$run" -parallel \
+            -decomposeParDict "$dict" > "$run/log.np$np" 2>&1 || {
+            echo "$solver: run on $np ranks failed"
+            cat "$run/log.np$np"
+            exit 1
+        }
+
+        compare "$run/log.serial" "$run/log.np$np" "$solver -np $np" \
+            || failed=1
+    done
+done
+
+exit $failed
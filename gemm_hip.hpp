@@ -0,0 +1,423 @@
+// gemm_hip.hpp
+// Register-blocked HIP GEMM kernels and a per-shape autotuner (row-major)
+//
+//   C = alpha*A*B + beta*C,  A: MxK (lda), B: KxN (ldb), C: MxN (ldc)
+//
+// A block computes a BMxBN tile of C from BK-deep slices of A and B staged
+// in shared memory. Each thread keeps a TMxTN sub-tile in registers; its
+// rows and columns are strided by the thread grid, so a wavefront reads
+// consecutive shared-memory words and writes whole rows of C coalesced.
+// Global loads are VW elements wide where the leading dimensions and base
+// pointers are aligned for it. As with BLAS, C is not read when beta == 0.
+//
+// The kernels are instantiated for the fixed list in kernels<T>(); add an
+// entry there to try another tile shape. Tuner times the candidates once
+// per device, shape and precision, keeps the fastest, and can persist its
+// choices to a file so later runs on the same device skip the tuning.
+#pragma once
+
+#include <hip/hip_runtime.h>
+#include <cctype>
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <map>
+#include <sstream>
+#include <string>
+#include <tuple>
+#include <vector>
+
+namespace gemm {
+
+// Widest global load any candidate kernel uses
+constexpr int maxVectorWidth = 4;
+
+struct KernelConfig {
+    int BM, BN, BK;     // block tile
+    int TM, TN;         // outputs per thread
+    int VW;             // global load width in elements
+
+    int threads() const { return (BM/TM)*(BN/TN); }
+
+    std::string name() const {
+        std::ostringstream os;
+        os << BM << 'x' << BN << 'x' << BK << '_' << TM << 'x' << TN << "_v" << VW;
+        return os.str();
+    }
+};
+
+template<typename T>
+using LaunchFn = hipError_t (*)(int M, int N, int K, T alpha, const T* A, int lda,
+                                const T* B, int ldb, T beta, T* C, int ldc,
+                                hipStream_t stream);
+
+template<typename T>
+struct Kernel {
+    KernelConfig config;
+    LaunchFn<T> launch;
+};
+
+namespace detail {
+
+template<typename T, int VW>
+struct alignas(sizeof(T)*VW) Vec {
+    T v[VW];
+};
+
+template<typename T, int BM, int BN, int BK, int TM, int TN, int VW>
+__global__ void __launch_bounds__((BM/TM)*(BN/TN))
+gemmKernel(int M, int N, int K, T alpha, const T* __restrict__ A, int lda,
+           const T* __restrict__ B, int ldb, T beta, T* __restrict__ C, int ldc) {
+    constexpr int TX = BN/TN;   // threads along N
+    constexpr int TY = BM/TM;   // threads along M
+    constexpr int NT = TX*TY;
+
+    static_assert(BM % TM == 0 && BN % TN == 0, "TMxTN must divide the tile");
+    static_assert(BK % VW == 0 && BN % VW == 0, "VW must divide the tile");
+
+    // A is stored k-major so both operands are read along tile rows in the
+    // inner loop; the pad spreads its transposing stores over the banks
+    __shared__ T sA[BK][BM + 1];
+    __shared__ T sB[BK][BN];
+
+    const int tid = threadIdx.x;
+    const int tx = tid % TX;
+    const int ty = tid / TX;
+    const int row0 = blockIdx.y*BM;
+    const int col0 = blockIdx.x*BN;
+
+    T acc[TM][TN];
+#pragma unroll
+    for (int i = 0; i < TM; ++i) {
+#pragma unroll
+        for (int j = 0; j < TN; ++j) acc[i][j] = T(0);
+    }
+
+    for (int k0 = 0; k0 < K; k0 += BK) {
+        // BMxBK slice of A, VW consecutive k per load
+        for (int e = tid*VW; e < BM*BK; e += NT*VW) {
+            const int r = e / BK;
+            const int c = e % BK;
+            const int gr = row0 + r;
+            const int gc = k0 + c;
+            T v[VW];
+
+            if (VW > 1 && gr < M && gc + VW <= K) {
+                const Vec<T, VW> x =
+                    *reinterpret_cast<const Vec<T, VW>*>(A + (size_t)gr*lda + gc);
+#pragma unroll
+                for (int w = 0; w < VW; ++w) v[w] = x.v[w];
+            } else {
+#pragma unroll
+                for (int w = 0; w < VW; ++w) {
+                    v[w] = (gr < M && gc + w < K) ? A[(size_t)gr*lda + gc + w] : T(0);
+                }
+            }
+#pragma unroll
+            for (int w = 0; w < VW; ++w) sA[c + w][r] = v[w];
+        }
+
+        // BKxBN slice of B, VW consecutive n per load
+        for (int e = tid*VW; e < BK*BN; e += NT*VW) {
+            const int r = e / BN;
+            const int c = e % BN;
+            const int gr = k0 + r;
+            const int gc = col0 + c;
+
+            if (VW > 1 && gr < K && gc + VW <= N) {
+                const Vec<T, VW> x =
+                    *reinterpret_cast<const Vec<T, VW>*>(B + (size_t)gr*ldb + gc);
+#pragma unroll
+                for (int w = 0; w < VW; ++w) sB[r][c + w] = x.v[w];
+            } else {
+#pragma unroll
+                for (int w = 0; w < VW; ++w) {
+                    sB[r][c + w] = (gr < K && gc + w < N) ? B[(size_t)gr*ldb + gc + w] : T(0);
+                }
+            }
+        }
+
+        __syncthreads();
+
+#pragma unroll
+        for (int k = 0; k < BK; ++k) {
+            T a[TM];
+            T b[TN];
+#pragma unroll
+            for (int i = 0; i < TM; ++i) a[i] = sA[k][ty + i*TY];
+#pragma unroll
+            for (int j = 0; j < TN; ++j) b[j] = sB[k][tx + j*TX];
+#pragma unroll
+            for (int i = 0; i < TM; ++i) {
+#pragma unroll
+                for (int j = 0; j < TN; ++j) acc[i][j] += a[i]*b[j];
+            }
+        }
+
+        __syncthreads();
+    }
+
+#pragma unroll
+    for (int i = 0; i < TM; ++i) {
+        const int r = row0 + ty + i*TY;
+        if (r >= M) continue;
+#pragma unroll
+        for (int j = 0; j < TN; ++j) {
+            const int c = col0 + tx + j*TX;
+            if (c >= N) continue;
+            T& out = C[(size_t)r*ldc + c];
+            out = beta == T(0) ? alpha*acc[i][j] : alpha*acc[i][j] + beta*out;
+        }
+    }
+}
+
+template<typename T, int BM, int BN, int BK, int TM, int TN, int VW>
+hipError_t launchKernel(int M, int N, int K, T alpha, const T* A, int lda,
+                        const T* B, int ldb, T beta, T* C, int ldc,
+                        hipStream_t stream) {
+    const dim3 grid((N + BN - 1)/BN, (M + BM - 1)/BM);
+    const dim3 block((BM/TM)*(BN/TN));
+
+    hipLaunchKernelGGL((gemmKernel<T, BM, BN, BK, TM, TN, VW>), grid, block, 0, stream,
+                       M, N, K, alpha, A, lda, B, ldb, beta, C, ldc);
+    return hipGetLastError();
+}
+
+inline bool aligned(const void* p, size_t bytes) {
+    return reinterpret_cast<std::uintptr_t>(p) % bytes == 0;
+}
+
+// Name and architecture of the current device, as one word
+inline std::string deviceTag() {
+    int device = 0;
+    hipDeviceProp_t prop;
+    if (hipGetDevice(&device) != hipSuccess
+     || hipGetDeviceProperties(&prop, device) != hipSuccess) {
+        hipGetLastError();
+        return "unknown";
+    }
+
+    std::string tag = std::string(prop.name) + '/' + prop.gcnArchName;
+    for (char& c : tag) {
+        if (std::isspace(static_cast<unsigned char>(c))) c = '_';
+    }
+    return tag;
+}
+
+template<typename T> inline char typeTag();
+template<> inline char typeTag<float>() { return 'f'; }
+template<> inline char typeTag<double>() { return 'd'; }
+
+} // namespace detail
+
+#define GEMM_KERNEL(BM, BN, BK, TM, TN, VW) \
+    {{BM, BN, BK, TM, TN, VW}, &detail::launchKernel<T, BM, BN, BK, TM, TN, VW>}
+
+// Candidate kernels; the first is the one-output-per-thread 16x16 tiling
+// the others are measured against
+template<typename T>
+const std::vector<Kernel<T>>& kernels() {
+    static const std::vector<Kernel<T>> list = {
+        GEMM_KERNEL( 16,  16, 16, 1, 1, 1),
+        GEMM_KERNEL( 32,  32, 16, 2, 2, 1),
+        GEMM_KERNEL( 64,  64, 16, 4, 4, 1),
+        GEMM_KERNEL( 64,  64,  8, 4, 4, 2),
+        GEMM_KERNEL( 64,  64, 16, 4, 4, 4),
+        GEMM_KERNEL(128,  64,  8, 8, 4, 4),
+        GEMM_KERNEL( 64, 128,  8, 4, 8, 4),
+        GEMM_KERNEL(128, 128,  8, 8, 8, 4),
+        GEMM_KERNEL(128, 128, 16, 8, 8, 4),
+    };
+    return list;
+}
+
+#undef GEMM_KERNEL
+
+// True if the operands allow the kernel's vector loads
+template<typename T>
+bool supported(const KernelConfig& config, const T* A, int lda, const T* B, int ldb) {
+    const int VW = config.VW;
+    return VW == 1
+        || (lda % VW == 0 && ldb % VW == 0
+         && detail::aligned(A, VW*sizeof(T)) && detail::aligned(B, VW*sizeof(T)));
+}
+
+// True if every candidate can run on the operands
+template<typename T>
+bool vectorLoads(const T* A, int lda, const T* B, int ldb) {
+    const KernelConfig widest{0, 0, 0, 0, 0, maxVectorWidth};
+    return supported(widest, A, lda, B, ldb);
+}
+
+class Tuner {
+    // Device, precision, M, N, K and whether vector loads are possible
+    typedef std::tuple<std::string, char, int, int, int, bool> Key;
+
+    // Entries of every device in the cache, so saving keeps the others'
+    std::map<Key, std::string> best_;
+    std::string device_;
+    std::string cacheFile_;
+    int repeat_;
+    double tuningMs_;
+    bool verbose_;
+
+    void load() {
+        if (cacheFile_.empty()) return;
+
+        // One entry per line; save() writes a '#' header, and malformed
+        // lines are skipped rather than ending the read
+        std::ifstream is(cacheFile_);
+        std::string line;
+        while (std::getline(is, line)) {
+            const size_t first = line.find_first_not_of(" \t");
+            if (first == std::string::npos || line[first] == '#') continue;
+
+            std::istringstream entry(line);
+            std::string device;
+            char type;
+            int M, N, K, vec;
+            std::string name;
+            if ((entry >> device >> type >> M >> N >> K >> vec >> name)
+             && (type == 'f' || type == 'd')) {
+                best_[Key(device, type, M, N, K, vec != 0)] = name;
+            }
+        }
+    }
+
+    void save() const {
+        if (cacheFile_.empty()) return;
+
+        std::ofstream os(cacheFile_);
+        os << "# device type M N K vectorLoads kernel\n";
+        for (const auto& entry : best_) {
+            const Key& k = entry.first;
+            os << std::get<0>(k) << ' ' << std::get<1>(k) << ' ' << std::get<2>(k) << ' '
+               << std::get<3>(k) << ' ' << std::get<4>(k) << ' ' << std::get<5>(k) << ' '
+               << entry.second << '\n';
+        }
+    }
+
+    template<typename T>
+    static const Kernel<T>* find(const std::string& name) {
+        for (const Kernel<T>& k : kernels<T>()) {
+            if (k.config.name() == name) return &k;
+        }
+        return nullptr;
+    }
+
+    // Time every eligible candidate on scratch operands of the shape
+    template<typename T>
+    const Kernel<T>& tune(int M, int N, int K, bool vectorLoads, hipStream_t stream) {
+        const std::vector<Kernel<T>>& list = kernels<T>();
+
+        // Leading dimensions padded so the vector candidates can run
+        const int VW = maxVectorWidth;
+        const int lda = vectorLoads ? (K + VW - 1)/VW*VW : K;
+        const int ldb = vectorLoads ? (N + VW - 1)/VW*VW : N;
+
+        T *A = nullptr, *B = nullptr, *C = nullptr;
+        hipEvent_t start, stop;
+        bool ok =
+            hipMalloc(&A, sizeof(T)*M*lda) == hipSuccess
+         && hipMalloc(&B, sizeof(T)*K*ldb) == hipSuccess
+         && hipMalloc(&C, sizeof(T)*M*N) == hipSuccess
+         && hipMemset(A, 0, sizeof(T)*M*lda) == hipSuccess
+         && hipMemset(B, 0, sizeof(T)*K*ldb) == hipSuccess;
+
+        hipEventCreate(&start);
+        hipEventCreate(&stop);
+
+        const Kernel<T>* best = &list[0];
+        float bestMs = -1;
+
+        for (size_t i = 0; ok && i < list.size(); ++i) {
+            const Kernel<T>& k = list[i];
+            if (!vectorLoads && k.config.VW > 1) continue;
+
+            // Warm-up; a launch failure (e.g. out of resources) rules it out
+            if (k.launch(M, N, K, T(1), A, lda, B, ldb, T(0), C, N, stream) != hipSuccess) {
+                continue;
+            }
+
+            hipEventRecord(start, stream);
+            for (int r = 0; r < repeat_; ++r) {
+                k.launch(M, N, K, T(1), A, lda, B, ldb, T(0), C, N, stream);
+            }
+            hipEventRecord(stop, stream);
+            hipEventSynchronize(stop);
+
+            float ms = 0;
+            hipEventElapsedTime(&ms, start, stop);
+            ms /= repeat_;
+            tuningMs_ += ms*(repeat_ + 1);
+
+            if (verbose_) {
+                std::printf("  tune %c %dx%dx%d %-18s %9.4f ms\n", detail::typeTag<T>(),
+                            M, N, K, k.config.name().c_str(), ms);
+            }
+
+            if (bestMs < 0 || ms < bestMs) {
+                best = &k;
+                bestMs = ms;
+            }
+        }
+
+        if (!ok) {
+            std::fprintf(stderr, "gemm::Tuner: cannot allocate %dx%dx%d scratch operands,"
+                         " using %s\n", M, N, K, best->config.name().c_str());
+            hipGetLastError();
+        }
+
+        hipEventDestroy(start);
+        hipEventDestroy(stop);
+        hipFree(A);
+        hipFree(B);
+        hipFree(C);
+
+        return *best;
+    }
+
+public:
+    // cacheFile: tuning results read at construction and rewritten after
+    // each new shape; empty for none. Only the entries of the device
+    // current at construction are used.
+    explicit Tuner(const std::string& cacheFile = "", int repeat = 5, bool verbose = false)
+        : device_(detail::deviceTag()), cacheFile_(cacheFile), repeat_(repeat),
+          tuningMs_(0), verbose_(verbose) {
+        load();
+    }
+
+    // Fastest kernel for the shape, tuned on first use
+    template<typename T>
+    const Kernel<T>& select(int M, int N, int K, bool vectorLoads, hipStream_t stream = 0) {
+        const Key key(device_, detail::typeTag<T>(), M, N, K, vectorLoads);
+
+        const auto iter = best_.find(key);
+        if (iter != best_.end()) {
+            if (const Kernel<T>* k = find<T>(iter->second)) return *k;
+        }
+
+        const Kernel<T>& k = tune<T>(M, N, K, vectorLoads, stream);
+        best_[key] = k.config.name();
+        save();
+        return k;
+    }
+
+    // C = alpha*A*B + beta*C with the tuned kernel for the shape
+    template<typename T>
+    hipError_t gemm(int M, int N, int K, T alpha, const T* A, int lda, const T* B, int ldb,
+                    T beta, T* C, int ldc, hipStream_t stream = 0) {
+        if (M <= 0 || N <= 0) return hipSuccess;
+
+        return select<T>(M, N, K, gemm::vectorLoads(A, lda, B, ldb), stream)
+            .launch(M, N, K, alpha, A, lda, B, ldb, beta, C, ldc, stream);
+    }
+
+    // Kernel time spent tuning so far
+    double tuningMs() const { return tuningMs_; }
+
+    // Device the choices are made for, as written to the cache
+    const std::string& device() const { return device_; }
+};
+
+} // namespace gemm
@@ -1,118 +1,261 @@
 // matmul_hip.cpp
-// Compile: hipcc -O3 -std=c++17 matmul_hip.cpp -o matmul_hip
-#include <hip/hip_runtime.h>
-#include <cstdio>
-#include <cstdlib>
+// Dense GEMM benchmark: tuned HIP kernels against the blocked CPU path
+// Compile: hipcc -O3 -std=c++17 -fopenmp -march=native matmul_hip.cpp -o matmul_hip
+//
+// Usage: matmul_hip [N] [options]
+//   -s, --sizes LIST   comma-separated square sizes N or shapes MxNxK
+//                      (default 256,512,1024,2048,4096)
+//   -t, --type T       float, double or both (default both)
+//   -r, --repeat R     timed runs per kernel (default 10)
+//   -c, --cache FILE   tuning cache (default gemm_tuning.txt; "" for none)
+//   -a, --all          time every candidate kernel, not only the tuned one
+//   -v, --verbose      print the tuning measurements
+//   --no-verify        skip the CPU reference
+//
+// For every shape and precision the tuner picks a kernel (tuning on first
+// use), which is timed against the baseline 16x16 one-output-per-thread
+// kernel. GFLOP/s counts 2*M*N*K; bandwidth counts reading A and B and
+// writing C once. The CPU path is timed and used as the reference.
+#include "gemm_hip.hpp"
+#include "gemm_cpu.hpp"
+#include <algorithm>
 #include <chrono>
 #include <cmath>
-#include <iostream>
-
-#define TILE 16
+#include <cstdio>
+#include <cstdlib>
+#include <limits>
+#include <sstream>
+#include <string>
+#include <vector>
 
-__global__ void matMulTiled(const float* A, const float* B, float* C, int N) {
-    __shared__ float sA[TILE][TILE];
-    __shared__ float sB[TILE][TILE];
+#define HIP_CHECK(expr) \
+    do { \
+        hipError_t err_ = (expr); \
+        if (err_ != hipSuccess) { \
+            std::fprintf(stderr, "%s:%d: %s: %s\n", __FILE__, __LINE__, #expr, \
+                         hipGetErrorString(err_)); \
+            std::exit(2); \
+        } \
+    } while (0)
 
-    int row = blockIdx.y * TILE + threadIdx.y;
-    int col = blockIdx.x * TILE + threadIdx.x;
-    float acc = 0.0f;
+struct Shape {
+    int M, N, K;
+};
 
-    int numPhases = (N + TILE - 1) / TILE;
-    for (int p = 0; p < numPhases; ++p) {
-        int aCol = p * TILE + threadIdx.x;
-        int bRow = p * TILE + threadIdx.y;
+struct Options {
+    std::vector<Shape> shapes;
+    bool runFloat = true;
+    bool runDouble = true;
+    int repeat = 10;
+    std::string cache = "gemm_tuning.txt";
+    bool all = false;
+    bool verbose = false;
+    bool verify = true;
+};
 
-        sA[threadIdx.y][threadIdx.x] = (row < N && aCol < N) ? A[row * N + aCol] : 0.0f;
-        sB[threadIdx.y][threadIdx.x] = (bRow < N && col < N) ? B[bRow * N + col] : 0.0f;
+// Median kernel time of repeated launches, after one warm-up
+template<typename T>
+double timeKernel(const gemm::Kernel<T>& k, const Shape& s, const T* dA, const T* dB,
+                  T* dC, int repeat) {
+    hipEvent_t start, stop;
+    HIP_CHECK(hipEventCreate(&start));
+    HIP_CHECK(hipEventCreate(&stop));
 
-        __syncthreads();
+    HIP_CHECK(k.launch(s.M, s.N, s.K, T(1), dA, s.K, dB, s.N, T(0), dC, s.N, 0));
 
-        for (int k = 0; k < TILE; ++k) {
-            acc += sA[threadIdx.y][k] * sB[k][threadIdx.x];
-        }
-        __syncthreads();
+    std::vector<float> times(repeat);
+    for (int r = 0; r < repeat; ++r) {
+        HIP_CHECK(hipEventRecord(start, 0));
+        k.launch(s.M, s.N, s.K, T(1), dA, s.K, dB, s.N, T(0), dC, s.N, 0);
+        HIP_CHECK(hipEventRecord(stop, 0));
+        HIP_CHECK(hipEventSynchronize(stop));
+        HIP_CHECK(hipEventElapsedTime(&times[r], start, stop));
     }
 
-    if (row < N && col < N) {
-        C[row * N + col] = acc;
-    }
+    HIP_CHECK(hipEventDestroy(start));
+    HIP_CHECK(hipEventDestroy(stop));
+
+    std::sort(times.begin(), times.end());
+    return times[repeat/2];
 }
 
-void cpuMatMul(const float* A, const float* B, float* C, int N) {
-    for (int i = 0; i < N; ++i) {
-        for (int j = 0; j < N; ++j) {
-            float s = 0.0f;
-            for (int k = 0; k < N; ++k) s += A[i*N + k] * B[k*N + j];
-            C[i*N + j] = s;
+double gflops(const Shape& s, double ms) {
+    return 2.0*s.M*s.N*s.K/(ms*1e6);
+}
+
+template<typename T>
+double gbytes(const Shape& s, double ms) {
+    const double elements = (double)s.M*s.K + (double)s.K*s.N + (double)s.M*s.N;
+    return elements*sizeof(T)/(ms*1e6);
+}
+
+// Returns false if the kernel result does not match the CPU reference
+template<typename T>
+bool run(const Shape& s, gemm::Tuner& tuner, const Options& opt) {
+    const char* type = sizeof(T) == sizeof(float) ? "float" : "double";
+    const size_t nA = (size_t)s.M*s.K, nB = (size_t)s.K*s.N, nC = (size_t)s.M*s.N;
+
+    std::vector<T> hA(nA), hB(nB), hC(nC), hRef(nC);
+
+    // Reproducible, non-negative so the relative error is well defined
+    for (size_t i = 0; i < nA; ++i) hA[i] = T((i % 17)*0.03125);
+    for (size_t i = 0; i < nB; ++i) hB[i] = T((i % 13)*0.0625);
+
+    T *dA, *dB, *dC;
+    HIP_CHECK(hipMalloc(&dA, nA*sizeof(T)));
+    HIP_CHECK(hipMalloc(&dB, nB*sizeof(T)));
+    HIP_CHECK(hipMalloc(&dC, nC*sizeof(T)));
+    HIP_CHECK(hipMemcpy(dA, hA.data(), nA*sizeof(T), hipMemcpyHostToDevice));
+    HIP_CHECK(hipMemcpy(dB, hB.data(), nB*sizeof(T), hipMemcpyHostToDevice));
+
+    const double tuned0 = tuner.tuningMs();
+    const gemm::Kernel<T>& best =
+        tuner.select<T>(s.M, s.N, s.K, gemm::vectorLoads(dA, s.K, dB, s.N));
+    const double tuneMs = tuner.tuningMs() - tuned0;
+
+    const double baseMs = timeKernel(gemm::kernels<T>()[0], s, dA, dB, dC, opt.repeat);
+
+    if (opt.all) {
+        for (const gemm::Kernel<T>& k : gemm::kernels<T>()) {
+            if (!gemm::supported(k.config, dA, s.K, dB, s.N)) continue;
+            const double ms = timeKernel(k, s, dA, dB, dC, opt.repeat);
+            std::printf("  %5d %5d %5d %-6s   %-18s %9.3f ms %9.1f GFLOP/s %8.1f GB/s\n",
+                        s.M, s.N, s.K, type, k.config.name().c_str(), ms,
+                        gflops(s, ms), gbytes<T>(s, ms));
         }
     }
-}
 
-int main(int argc, char** argv) {
-    int N = 1024;
-    if (argc > 1) N = std::atoi(argv[1]);
+    const double ms = timeKernel(best, s, dA, dB, dC, opt.repeat);
+    HIP_CHECK(hipMemcpy(hC.data(), dC, nC*sizeof(T), hipMemcpyDeviceToHost));
+
+    double cpuMs = 0;
+    double err = 0;
+    bool ok = true;
 
-    size_t bytes = (size_t)N * N * sizeof(float);
-    float *hA = (float*)malloc(bytes), *hB = (float*)malloc(bytes), *hC = (float*)malloc(bytes);
-    float *hC_ref = (float*)malloc(bytes);
+    if (opt.verify) {
+        const auto t0 = std::chrono::steady_clock::now();
+        gemm::cpuGemm<T>(s.M, s.N, s.K, T(1), hA.data(), s.K, hB.data(), s.N, T(0),
+                         hRef.data(), s.N);
+        const auto t1 = std::chrono::steady_clock::now();
+        cpuMs = std::chrono::duration<double, std::milli>(t1 - t0).count();
+
+        double maxRef = 0;
+        for (size_t i = 0; i < nC; ++i) {
+            err = std::fmax(err, std::fabs((double)hRef[i] - (double)hC[i]));
+            maxRef = std::fmax(maxRef, std::fabs((double)hRef[i]));
+        }
+        if (maxRef > 0) err /= maxRef;
 
-    // Initialize
-    for (size_t i = 0; i < (size_t)N * N; ++i) {
-        hA[i] = static_cast<float>( (i % 17) * 0.03125f ); // reproducible-ish
-        hB[i] = static_cast<float>( (i % 13) * 0.0625f );
+        // Rounding in a K-term sum of non-negative terms is below K*eps
+        const double tol = 4.0*std::max(s.K, 1)*std::numeric_limits<T>::epsilon();
+        ok = err <= tol;
     }
 
-    // Device buffers
-    float *dA, *dB, *dC;
-    hipMalloc(&dA, bytes);
-    hipMalloc(&dB, bytes);
-    hipMalloc(&dC, bytes);
+    std::printf("%5d %5d %5d %-6s %-18s %9.3f %9.1f %8.1f %6.2fx %8.1f",
+                s.M, s.N, s.K, type, best.config.name().c_str(), ms, gflops(s, ms),
+                gbytes<T>(s, ms), baseMs/ms, tuneMs);
+    if (opt.verify) {
+        std::printf(" %10.2f %8.1f %10.2e%s\n", cpuMs, gflops(s, cpuMs), err,
+                    ok ? "" : "  FAILED");
+    } else {
+        std::printf("\n");
+    }
 
-    hipMemcpy(dA, hA, bytes, hipMemcpyHostToDevice);
-    hipMemcpy(dB, hB, bytes, hipMemcpyHostToDevice);
+    HIP_CHECK(hipFree(dA));
+    HIP_CHECK(hipFree(dB));
+    HIP_CHECK(hipFree(dC));
 
-    dim3 block(TILE, TILE);
-    dim3 grid( (N + TILE - 1) / TILE, (N + TILE - 1) / TILE );
+    return ok;
+}
 
-    // GPU timing with hip events
-    hipEvent_t start, stop;
-    hipEventCreate(&start);
-    hipEventCreate(&stop);
-    hipEventRecord(start, 0);
+bool parseShape(const std::string& item, Shape& s) {
+    int M = 0, N = 0, K = 0;
+    char x1 = 0, x2 = 0;
+    std::istringstream is(item);
 
-    hipLaunchKernelGGL(matMulTiled, grid, block, 0, 0, dA, dB, dC, N);
+    if ((is >> M >> x1 >> N >> x2 >> K) && x1 == 'x' && x2 == 'x') {
+        s = Shape{M, N, K};
+    } else if (std::sscanf(item.c_str(), "%d", &M) == 1 && item.find('x') == std::string::npos) {
+        s = Shape{M, M, M};
+    } else {
+        return false;
+    }
+    return s.M > 0 && s.N > 0 && s.K > 0;
+}
 
-    hipEventRecord(stop, 0);
-    hipEventSynchronize(stop);
+void usage(const char* prog) {
+    std::fprintf(stderr,
+        "Usage: %s [N] [-s N,MxNxK,...] [-t float|double|both] [-r repeat]\n"
+        "          [-c cacheFile] [-a] [-v] [--no-verify]\n", prog);
+    std::exit(1);
+}
 
-    float ms = 0.0f;
-    hipEventElapsedTime(&ms, start, stop);
+int main(int argc, char** argv) {
+    Options opt;
 
-    hipMemcpy(hC, dC, bytes, hipMemcpyDeviceToHost);
+    for (int i = 1; i < argc; ++i) {
+        const std::string arg = argv[i];
+        const bool hasValue = i + 1 < argc;
 
-    // CPU reference (time it)
-    auto t0 = std::chrono::high_resolution_clock::now();
-    cpuMatMul(hA, hB, hC_ref, N);
-    auto t1 = std::chrono::high_resolution_clock::now();
-    double cpu_ms = std::chrono::duration<double, std::milli>(t1 - t0).count();
+        if ((arg == "-s" || arg == "--sizes") && hasValue) {
+            std::istringstream list(argv[++i]);
+            std::string item;
+            while (std::getline(list, item, ',')) {
+                Shape s;
+                if (!parseShape(item, s)) usage(argv[0]);
+                opt.shapes.push_back(s);
+            }
+        } else if ((arg == "-t" || arg == "--type") && hasValue) {
+            const std::string t = argv[++i];
+            opt.runFloat = t == "float" || t == "both";
+            opt.runDouble = t == "double" || t == "both";
+            if (!opt.runFloat && !opt.runDouble) usage(argv[0]);
+        } else if ((arg == "-r" || arg == "--repeat") && hasValue) {
+            opt.repeat = std::max(1, std::atoi(argv[++i]));
+        } else if ((arg == "-c" || arg == "--cache") && hasValue) {
+            opt.cache = argv[++i];
+        } else if (arg == "-a" || arg == "--all") {
+            opt.all = true;
+        } else if (arg == "-v" || arg == "--verbose") {
+            opt.verbose = true;
+        } else if (arg == "--no-verify") {
+            opt.verify = false;
+        } else {
+            // A bare size, as the original single-size driver took
+            Shape s;
+            if (!parseShape(arg, s)) usage(argv[0]);
+            opt.shapes.push_back(s);
+        }
+    }
 
-    // Verify
-    double max_err = 0.0;
-    for (size_t i = 0; i < (size_t)N * N; ++i) {
-        max_err = std::fmax(max_err, std::fabs(static_cast<double>(hC_ref[i]) - hC[i]));
+    if (opt.shapes.empty()) {
+        for (int n : {256, 512, 1024, 2048, 4096}) opt.shapes.push_back(Shape{n, n, n});
     }
 
-    std::printf("N=%d | GPU kernel time: %.3f ms | CPU time: %.3f ms | max error: %.6e\n",
-                N, ms, cpu_ms, max_err);
+    hipDeviceProp_t prop;
+    HIP_CHECK(hipGetDeviceProperties(&prop, 0));
 
-    // Cleanup
-    hipFree(dA);
-    hipFree(dB);
-    hipFree(dC);
-    free(hA); free(hB); free(hC); free(hC_ref);
+    int nThreads = 1;
+#ifdef _OPENMP
+    nThreads = omp_get_max_threads();
+#endif
 
-    hipEventDestroy(start);
-    hipEventDestroy(stop);
+    std::printf("Device: %s | CPU threads: %d | tuning cache: %s\n\n", prop.name, nThreads,
+                opt.cache.empty() ? "none" : opt.cache.c_str());
+    std::printf("%5s %5s %5s %-6s %-18s %9s %9s %8s %7s %8s", "M", "N", "K", "type",
+                "kernel", "ms", "GFLOP/s", "GB/s", "vs16x16", "tune ms");
+    if (opt.verify) {
+        std::printf(" %10s %8s %10s", "CPU ms", "GFLOP/s", "rel err");
+    }
+    std::printf("\n");
+
+    gemm::Tuner tuner(opt.cache, 5, opt.verbose);
+    bool ok = true;
+
+    for (const Shape& s : opt.shapes) {
+        if (opt.runFloat) ok = run<float>(s, tuner, opt) && ok;
+        if (opt.runDouble) ok = run<double>(s, tuner, opt) && ok;
+    }
 
-    return (max_err < 1e-2) ? 0 : 1;
+    return ok ? 0 : 1;
 }